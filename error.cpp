@@ -21,6 +21,32 @@ void Error::PrintLexicalError(int code) {
          scanner_->GetLine(), scanner_->GetCol(), lexical_error_name[code]);
 }
 
+const char *preprocess_error_name[] = {
+    "Include file can not be found",
+    "Include nesting is too deep",
+    "Directive is malformed",
+    "Directive does not exist",
+    "Error directive",
+    "Macro argument count is not consistent with parameters",
+    "Macro arguments miss right parenthesis",
+    "Conditional expression is invalid",
+    "Conditional branch has no #if",
+    "Conditional branch occurs after #else",
+    "#endif has no #if",
+    "#if misses #endif",
+    "Multi-line comment does not end at the end of file"};
+
+void Error::PrintPreprocessError(int code, const std::string &file, int line,
+                                 const std::string &name) {
+  IncrErrorNum();
+  if (name.empty())
+    printf("%s<line %d> PreprocessError: %s.\n", file.c_str(), line,
+           preprocess_error_name[code]);
+  else
+    printf("%s<line %d> PreprocessError: %s: %s.\n", file.c_str(), line,
+           preprocess_error_name[code], name.c_str());
+}
+
 void Error::PrintSyntaxError(int code, std::shared_ptr<Token> token){
 }
 
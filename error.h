@@ -17,6 +17,22 @@ enum LexicalError {
   TOKEN_NO_EXIST
 };
 
+enum PreprocessError {
+  INCLUDE_NOT_FOUND, // include file can not be found
+  INCLUDE_TOO_DEEP,  // include nesting exceeds the limit
+  DIRECTIVE_INVALID, // directive is malformed
+  DIRECTIVE_UNKNOWN, // directive does not exist
+  DIRECTIVE_ERROR,   // #error directive
+  MACRO_ARG_ERR,     // macro argument count is not consistent with parameters
+  MACRO_ARG_NO_END,  // macro arguments miss right parenthesis
+  IF_EXPR_INVALID,   // #if expression is invalid
+  ELSE_NO_IF,        // #elif or #else occurs without #if
+  ELSE_AFTER_ELSE,   // #elif or #else occurs after #else
+  ENDIF_NO_IF,       // #endif occurs without #if
+  IF_NO_ENDIF,       // #if misses #endif at the end of file
+  COMMENT_NOT_END    // multi-line comment misses */ at the end of file
+};
+
 enum SyntaxError {
   TYPE_LOST,
   TYPE_WRONG,
@@ -118,6 +134,8 @@ public:
   }
 
   static void PrintLexicalError(int code);
+  static void PrintPreprocessError(int code, const std::string &file, int line,
+                                   const std::string &name = "");
   static void PrintSyntaxError(int code, std::shared_ptr<Token> token);
   static void PrintSemanticError(int code, const std::string &name = "");
   static void PrintSemanticWarning(int code, const std::string &name = "");
@@ -0,0 +1,83 @@
+/*Switch-dispatch bytecode interpreter*/
+
+int code[64];
+int reg[8];
+
+// Each instruction is an opcode followed by three operands
+void emit(int pc, int op, int a, int b, int c) {
+  code[pc * 4] = op;
+  code[pc * 4 + 1] = a;
+  code[pc * 4 + 2] = b;
+  code[pc * 4 + 3] = c;
+}
+
+// Sum i * i % 65536 for i in [0, n)
+void assemble(int n) {
+  emit(0, 1, 0, 0, 0);     // r0 = 0 (sum)
+  emit(1, 1, 1, 0, 0);     // r1 = 0 (i)
+  emit(2, 1, 2, n, 0);     // r2 = n
+  emit(3, 1, 3, 1, 0);     // r3 = 1
+  emit(4, 1, 4, 65536, 0); // r4 = 65536
+  emit(5, 5, 5, 1, 2);     // loop: r5 = r1 < r2
+  emit(6, 6, 5, 12, 0);    // if r5 == 0 goto end
+  emit(7, 3, 6, 1, 1);     // r6 = r1 * r1
+  emit(8, 2, 0, 0, 6);     // r0 = r0 + r6
+  emit(9, 4, 0, 0, 4);     // r0 = r0 % r4
+  emit(10, 2, 1, 1, 3);    // r1 = r1 + r3
+  emit(11, 7, 5, 0, 0);    // goto loop
+  emit(12, 0, 0, 0, 0);    // end: halt with r0
+}
+
+int run() {
+  int pc = 0;
+  int op;
+  int a;
+  int b;
+  int c;
+  while (1) {
+    op = code[pc * 4];
+    a = code[pc * 4 + 1];
+    b = code[pc * 4 + 2];
+    c = code[pc * 4 + 3];
+    pc = pc + 1;
+    switch (op) {
+    case 0:
+      return reg[a];
+    case 1:
+      reg[a] = b;
+      break;
+    case 2:
+      reg[a] = reg[b] + reg[c];
+      break;
+    case 3:
+      reg[a] = reg[b] * reg[c];
+      break;
+    case 4:
+      reg[a] = reg[b] % reg[c];
+      break;
+    case 5:
+      reg[a] = reg[b] < reg[c];
+      break;
+    case 6:
+      if (reg[a] == 0)
+        pc = b;
+      break;
+    case 7:
+      pc = a;
+      break;
+    default:
+      return 255;
+    }
+  }
+  return 255;
+}
+
+int main() {
+  int round;
+  int sum = 0;
+  for (round = 0; round < 3000; round = round + 1) {
+    assemble(round % 500);
+    sum = (sum + run()) % 65536;
+  }
+  return sum % 256;
+}
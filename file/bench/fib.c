@@ -0,0 +1,19 @@
+/*Recursive calls*/
+
+int fib(int n) {
+  if (n < 2)
+    return n;
+  return fib(n - 1) + fib(n - 2);
+}
+
+int ackermann(int m, int n) {
+  if (m == 0)
+    return n + 1;
+  if (n == 0)
+    return ackermann(m - 1, 1);
+  return ackermann(m - 1, ackermann(m, n - 1));
+}
+
+int main() {
+  return (fib(27) + ackermann(2, 200)) % 256;
+}
@@ -0,0 +1,42 @@
+/*Integer matrix multiplication*/
+
+int lhs[4096];
+int rhs[4096];
+int result[4096];
+
+void init() {
+  int i;
+  for (i = 0; i < 4096; i = i + 1) {
+    lhs[i] = i % 17 - 8;
+    rhs[i] = i % 13 - 6;
+  }
+}
+
+void multiply() {
+  int i;
+  int j;
+  int k;
+  int sum;
+  for (i = 0; i < 64; i = i + 1) {
+    for (j = 0; j < 64; j = j + 1) {
+      sum = 0;
+      for (k = 0; k < 64; k = k + 1)
+        sum = sum + lhs[i * 64 + k] * rhs[k * 64 + j];
+      result[i * 64 + j] = sum;
+    }
+  }
+}
+
+int main() {
+  int round;
+  int i;
+  int sum = 0;
+  init();
+  for (round = 0; round < 50; round = round + 1) {
+    multiply();
+    lhs[round] = lhs[round] + 1;
+  }
+  for (i = 0; i < 4096; i = i + 1)
+    sum = (sum + result[i]) % 65536;
+  return (sum + 65536) % 256;
+}
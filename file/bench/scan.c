@@ -0,0 +1,64 @@
+/*String scanning over a generated text*/
+
+char text[8192];
+
+void generate(int seed) {
+  int i;
+  for (i = 0; i < 8191; i = i + 1) {
+    seed = (seed * 75 + 74) % 65537;
+    if (seed % 7 == 0)
+      text[i] = ' ';
+    else if (seed % 31 == 0)
+      text[i] = '\n';
+    else
+      text[i] = 'a' + seed % 26;
+  }
+  text[8191] = 0;
+}
+
+int words() {
+  int i = 0;
+  int count = 0;
+  int in_word = 0;
+  while (text[i]) {
+    if (text[i] == ' ' || text[i] == '\n') {
+      in_word = 0;
+    } else if (in_word == 0) {
+      in_word = 1;
+      count = count + 1;
+    }
+    i = i + 1;
+  }
+  return count;
+}
+
+int vowels() {
+  int i;
+  int count = 0;
+  char ch;
+  for (i = 0; text[i]; i = i + 1) {
+    ch = text[i];
+    switch (ch) {
+    case 'a':
+    case 'e':
+    case 'i':
+    case 'o':
+    case 'u':
+      count = count + 1;
+      break;
+    default:
+      break;
+    }
+  }
+  return count;
+}
+
+int main() {
+  int round;
+  int sum = 0;
+  for (round = 0; round < 300; round = round + 1) {
+    generate(round);
+    sum = (sum + words() + vowels()) % 65536;
+  }
+  return sum % 256;
+}
@@ -0,0 +1,42 @@
+/*Insertion sort of pseudo-random numbers*/
+
+int data[512];
+
+void fill(int seed) {
+  int i;
+  for (i = 0; i < 512; i = i + 1) {
+    seed = (seed * 1103 + 12345) % 65536;
+    data[i] = seed;
+  }
+}
+
+void sort() {
+  int i;
+  int j;
+  int key;
+  for (i = 1; i < 512; i = i + 1) {
+    key = data[i];
+    j = i - 1;
+    while (j >= 0 && data[j] > key) {
+      data[j + 1] = data[j];
+      j = j - 1;
+    }
+    data[j + 1] = key;
+  }
+}
+
+int main() {
+  int round;
+  int i;
+  int sum = 0;
+  for (round = 0; round < 200; round = round + 1) {
+    fill(round);
+    sort();
+    for (i = 1; i < 512; i = i + 1) {
+      if (data[i - 1] > data[i])
+        return 255;
+    }
+    sum = (sum + data[round]) % 65536;
+  }
+  return sum % 256;
+}
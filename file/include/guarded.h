@@ -0,0 +1,7 @@
+#ifndef GUARDED_H
+#define GUARDED_H
+/* Included twice, read once */
+#define SIZE 16
+#define LEVEL 1
+extern int get(int index);
+#endif
@@ -0,0 +1,2 @@
+extern int bad(int a);
+int c = 'x;
@@ -0,0 +1,2 @@
+#pragma once
+extern void put(int value);
@@ -0,0 +1,41 @@
+/*Preprocess*/
+#include "include/guarded.h"
+#include "include/guarded.h"
+#include <once.h>
+#include "include/once.h"
+
+#define SQUARE(x) ((x) * (x))
+#define ADD(a, b) ((a) + (b))
+#define TWICE(x) ADD(x, x) // nested expansion
+#define PLUS ADD // rescanned with the arguments that follow
+#define NEG -1
+#define ID(x) x
+#define ZERO 0 /* a comment opened in a directive
+                  ends here */ int zero = ZERO;
+
+int main() {
+  int a = SQUARE(SIZE);
+  int b = ADD(a, SQUARE(2));
+  int c = TWICE(b);
+  int f = PLUS(a,
+               c); // call continues on the next line
+  // Replacements do not join with neighbouring tokens
+  int g = -NEG;
+  int ID(int)h = ID(+)+1;
+#if defined(DEBUG) && LEVEL > 1
+  int d = 1;
+#elif LEVEL == 1
+  int d = 2;
+#else
+  int d = 3;
+#endif
+#ifdef UNDEFINED
+  int e = 4;
+#endif
+#if LEVEL == 1 || LEVEL / 0 // short circuit, no division by zero
+  int e = 5;
+#endif
+  put(get(d)); /* SIZE in a comment is not expanded
+  and the comment */ put(SIZE); /* is replaced by a blank */
+  return 0;
+}
@@ -0,0 +1,5 @@
+#include "include/intended_error.h"
+int main() {
+  "love;
+  return 0;
+}
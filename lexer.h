@@ -162,7 +162,7 @@ private:
     Scan();
     char c;
     // Escape character
-    if (ch_ = '\\') {
+    if (ch_ == '\\') {
       Scan();
       if (ch_ == 'n')
         c = '\n';
@@ -216,21 +216,32 @@ private:
 
   void TokenizeDelimiter() {
     switch (ch_) {
-    // Ignore  macro
+    // Directives and macro operators are handled by the Preprocessor
     case '#':
-      while (ch_ != '\n' && ch_ != -1)
-        // Eat one more character here
-        Scan();
-      break;
-    case '+':
-      token_ = std::make_shared<Delimiter>(Scan('+') ? INC : ADD);
+      token_ = std::make_shared<Token>(ERR);
+      Error::PrintLexicalError(TOKEN_NO_EXIST);
       // Eat one more character here
       Scan();
       break;
+    case '+':
+      if (Scan('+')) {
+        token_ = std::make_shared<Delimiter>(INC);
+        // Eat one more character here
+        Scan();
+      } else {
+        // The character after the operator is already read
+        token_ = std::make_shared<Delimiter>(ADD);
+      }
+      break;
     case '-':
-      token_ = std::make_shared<Delimiter>(Scan('-') ? DEC : SUB);
-      // Eat one more character here
-      Scan();
+      if (Scan('-')) {
+        token_ = std::make_shared<Delimiter>(DEC);
+        // Eat one more character here
+        Scan();
+      } else {
+        // The character after the operator is already read
+        token_ = std::make_shared<Delimiter>(SUB);
+      }
       break;
     case '*':
       token_ = std::make_shared<Delimiter>(MUL);
@@ -283,24 +294,44 @@ private:
       Scan();
       break;
     case '>':
-      token_ = std::make_shared<Delimiter>(Scan('=') ? GE : GT);
-      // Eat one more character here
-      Scan();
+      if (Scan('=')) {
+        token_ = std::make_shared<Delimiter>(GE);
+        // Eat one more character here
+        Scan();
+      } else {
+        // The character after the operator is already read
+        token_ = std::make_shared<Delimiter>(GT);
+      }
       break;
     case '<':
-      token_ = std::make_shared<Delimiter>(Scan('=') ? LE : LT);
-      // Eat one more character here
-      Scan();
+      if (Scan('=')) {
+        token_ = std::make_shared<Delimiter>(LE);
+        // Eat one more character here
+        Scan();
+      } else {
+        // The character after the operator is already read
+        token_ = std::make_shared<Delimiter>(LT);
+      }
       break;
     case '=':
-      token_ = std::make_shared<Delimiter>(Scan('=') ? EQU : ASSIGN);
-      // Eat one more character here
-      Scan();
+      if (Scan('=')) {
+        token_ = std::make_shared<Delimiter>(EQU);
+        // Eat one more character here
+        Scan();
+      } else {
+        // The character after the operator is already read
+        token_ = std::make_shared<Delimiter>(ASSIGN);
+      }
       break;
     case '&':
-      token_ = std::make_shared<Delimiter>(Scan('&') ? AND : LEA);
-      // Eat one more character here
-      Scan();
+      if (Scan('&')) {
+        token_ = std::make_shared<Delimiter>(AND);
+        // Eat one more character here
+        Scan();
+      } else {
+        // The character after the operator is already read
+        token_ = std::make_shared<Delimiter>(LEA);
+      }
       break;
     case '|':
       if (Scan('|')) {
@@ -0,0 +1,1088 @@
+#pragma once
+#include "error.h"
+#include "lexer.h"
+#include "scanner.h"
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace akan {
+// Preprocessing stage in front of the Lexer. It supports #include,
+// object-like and function-like #define, #undef, #if/#ifdef/#ifndef/#elif/
+// #else/#endif, #pragma once and #error. Stringizing (#) and token pasting
+// (##) are not supported and are reported as invalid #define.
+//
+// The result is scanned with Scanner(name, content, GetLineMarks()) and
+// tokenized by the Lexer.
+//
+// Comments are replaced by a blank as in C translation phase 3, and a
+// multi-line comment keeps its line breaks. Directives and skipped lines are
+// replaced by empty lines, so the line numbers of a file without #include are
+// unchanged for the Scanner. Files are read from disk once and cached in
+// memory; a header wrapped in an include guard is skipped without being
+// looked at again once its guard is defined.
+class Preprocessor {
+private:
+  struct Macro {
+    bool function_like = false;
+    std::vector<std::string> params;
+    std::string body;
+  };
+
+  // State of an #if group
+  struct Condition {
+    bool parent_active; // whether the enclosing group is active
+    bool taken;         // whether a branch of the group has been active
+    bool active;        // whether the current branch is active
+    bool has_else;      // whether #else has occurred
+  };
+
+  // Include guard detection: #ifndef X ... #endif wrapping the whole file
+  enum GuardState { GUARD_START, GUARD_IN, GUARD_AFTER, GUARD_NONE };
+
+  // File being processed
+  struct FileState {
+    std::string path;         // canonical path, the key of per-file tables
+    std::string name;         // path as spelled, for diagnostics
+    int line;                 // line number of the current logical line
+    std::size_t cond_base;    // size of conditions_ when the file is entered
+    GuardState guard_state;
+    std::string guard;        // include guard macro candidate
+  };
+
+  // Per-header cost statistics
+  struct IncludeStat {
+    std::string name;      // path as spelled the first time
+    int includes = 0;      // times the file is requested
+    int skips = 0;         // requests skipped by include guard or #pragma once
+    int reads = 0;         // times the file is read from disk
+    int lines = 0;         // physical lines processed
+    std::size_t bytes = 0; // bytes processed
+    double micros = 0;     // time spent, nested includes included
+  };
+
+  static constexpr int max_include_depth_ = 200;
+
+  std::vector<std::string> include_dirs_;
+  std::unordered_map<std::string, Macro> predefined_;
+  std::unordered_map<std::string, Macro> macros_;
+  std::vector<Condition> conditions_;
+  std::vector<FileState> files_;
+  // Errors are counted but not printed while probing a macro call
+  bool quiet_ = false;
+  int quiet_errors_ = 0;
+  // Output line being generated and where output lines come from
+  int out_line_ = 1;
+  std::vector<LineMark> line_marks_;
+  // Unlike an include guard, #pragma once does not depend on macros and only
+  // holds within one translation unit
+  std::set<std::string> pragma_once_;
+
+  // Kept across translation units
+  std::unordered_map<std::string, std::shared_ptr<const std::string>>
+      file_cache_;
+  std::unordered_map<std::string, std::string> include_guards_;
+  std::map<std::string, IncludeStat> stats_;
+
+  static bool IsIdentifierStart(char ch) {
+    return std::isalpha(static_cast<unsigned char>(ch)) || ch == '_';
+  }
+
+  static bool IsIdentifierChar(char ch) {
+    return std::isalnum(static_cast<unsigned char>(ch)) || ch == '_';
+  }
+
+  static void SkipSpace(const std::string &text, std::size_t &pos) {
+    while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t'))
+      ++pos;
+  }
+
+  static std::string Trim(const std::string &text) {
+    std::size_t begin = text.find_first_not_of(" \t");
+    if (begin == std::string::npos)
+      return "";
+    std::size_t end = text.find_last_not_of(" \t");
+    return text.substr(begin, end - begin + 1);
+  }
+
+  static std::string ReadIdentifier(const std::string &text,
+                                    std::size_t &pos) {
+    std::size_t begin = pos;
+    if (pos < text.size() && IsIdentifierStart(text[pos])) {
+      do {
+        ++pos;
+      } while (pos < text.size() && IsIdentifierChar(text[pos]));
+    }
+    return text.substr(begin, pos - begin);
+  }
+
+  // Read a string or character literal, an unterminated one ends at the end
+  // of text and is left to the Lexer to report
+  static std::string ReadLiteral(const std::string &text, std::size_t &pos) {
+    std::size_t begin = pos;
+    char quote = text[pos++];
+    while (pos < text.size() && text[pos] != quote) {
+      if (text[pos] == '\\')
+        ++pos;
+      ++pos;
+    }
+    if (pos < text.size())
+      ++pos;
+    else
+      pos = text.size();
+    return text.substr(begin, pos - begin);
+  }
+
+  // Read a logical line, joining backslash-newline continuations, and return
+  // the number of physical lines it spans
+  static int ReadLine(const std::string &content, std::size_t &pos,
+                      std::string &line) {
+    int count = 1;
+    line.clear();
+    while (pos < content.size()) {
+      char ch = content[pos++];
+      if (ch == '\n') {
+        if (!line.empty() && line.back() == '\\') {
+          line.pop_back();
+          ++count;
+          continue;
+        }
+        break;
+      }
+      line.push_back(ch);
+    }
+    return count;
+  }
+
+  // Split a line into code (false) and comment (true) segments. in_comment
+  // carries an unterminated multi-line comment over to the next line.
+  static std::vector<std::pair<bool, std::string>>
+  SplitComments(const std::string &line, bool &in_comment) {
+    std::vector<std::pair<bool, std::string>> segments;
+    std::size_t pos = 0;
+    std::string code;
+    while (pos < line.size()) {
+      if (in_comment) {
+        std::size_t end = line.find("*/", pos);
+        in_comment = end == std::string::npos;
+        end = in_comment ? line.size() : end + 2;
+        segments.emplace_back(true, line.substr(pos, end - pos));
+        pos = end;
+      } else if (line[pos] == '"' || line[pos] == '\'') {
+        code += ReadLiteral(line, pos);
+      } else if (line.compare(pos, 2, "//") == 0) {
+        segments.emplace_back(false, std::move(code));
+        segments.emplace_back(true, line.substr(pos));
+        code.clear();
+        pos = line.size();
+      } else if (line.compare(pos, 2, "/*") == 0) {
+        segments.emplace_back(false, std::move(code));
+        code.clear();
+        // Skip "/*" so that "/*/" does not end the comment
+        std::size_t end = line.find("*/", pos + 2);
+        in_comment = end == std::string::npos;
+        end = in_comment ? line.size() : end + 2;
+        segments.emplace_back(true, line.substr(pos, end - pos));
+        pos = end;
+      } else {
+        code.push_back(line[pos++]);
+      }
+    }
+    if (!code.empty())
+      segments.emplace_back(false, std::move(code));
+    return segments;
+  }
+
+  // Replace each comment by a blank
+  static std::string StripComments(const std::string &line, bool &in_comment) {
+    std::string code;
+    for (auto &segment : SplitComments(line, in_comment))
+      code += segment.first ? std::string(" ") : segment.second;
+    return code;
+  }
+
+  void PrintError(int code, const std::string &name = "") {
+    if (quiet_) {
+      ++quiet_errors_;
+      return;
+    }
+    if (files_.empty())
+      Error::PrintPreprocessError(code, "", 0, name);
+    else
+      Error::PrintPreprocessError(code, files_.back().name, files_.back().line,
+                                  name);
+  }
+
+  // Record the source of the current output line unless it follows the
+  // last mark
+  void MarkLine() {
+    const FileState &file = files_.back();
+    if (!line_marks_.empty()) {
+      LineMark &mark = line_marks_.back();
+      if (mark.file == file.name &&
+          mark.source_line + out_line_ - mark.line == file.line)
+        return;
+      // Lines of an included file start on the line of the #include
+      if (mark.line == out_line_) {
+        mark = {out_line_, file.name, file.line};
+        return;
+      }
+    }
+    line_marks_.push_back({out_line_, file.name, file.line});
+  }
+
+  bool IsActive() { return conditions_.empty() || conditions_.back().active; }
+
+  // Macro expansion
+  // Read the arguments of a function-like macro call starting at '('
+  static bool ReadArguments(const std::string &text, std::size_t &pos,
+                            std::vector<std::string> &args) {
+    int depth = 0;
+    std::string arg;
+    while (pos < text.size()) {
+      char ch = text[pos];
+      if (ch == '"' || ch == '\'') {
+        arg += ReadLiteral(text, pos);
+        continue;
+      }
+      ++pos;
+      if (ch == '(') {
+        if (depth++ == 0)
+          continue;
+      } else if (ch == ')') {
+        if (--depth == 0) {
+          args.push_back(std::move(arg));
+          return true;
+        }
+      } else if (ch == ',' && depth == 1) {
+        args.push_back(std::move(arg));
+        arg.clear();
+        continue;
+      }
+      arg.push_back(ch);
+    }
+    return false;
+  }
+
+  // Whether two characters written next to each other could be read as one
+  // token, e.g. "-" and "-1" or "int" and "b"
+  static bool Joins(char lhs, char rhs) {
+    static const std::string operators = "+-<>&|=";
+    return (IsIdentifierChar(lhs) && IsIdentifierChar(rhs)) ||
+           (operators.find(lhs) != std::string::npos &&
+            operators.find(rhs) != std::string::npos);
+  }
+
+  // Arguments are separated by a blank from the body where they would join
+  // with it
+  static std::string Substitute(const Macro &macro,
+                                const std::vector<std::string> &args) {
+    std::string result;
+    const std::string &body = macro.body;
+    std::size_t pos = 0;
+    bool after_arg = false;
+    while (pos < body.size()) {
+      char ch = body[pos];
+      if (after_arg && Joins(result.back(), ch))
+        result.push_back(' ');
+      after_arg = false;
+      if (ch == '"' || ch == '\'') {
+        result += ReadLiteral(body, pos);
+      } else if (IsIdentifierStart(ch)) {
+        std::string name = ReadIdentifier(body, pos);
+        std::size_t i = 0;
+        while (i < macro.params.size() && macro.params[i] != name)
+          ++i;
+        if (i == macro.params.size()) {
+          result += name;
+          continue;
+        }
+        const std::string &arg = args[i];
+        if (!arg.empty() && !result.empty() && Joins(result.back(), arg[0]))
+          result.push_back(' ');
+        result += arg;
+        after_arg = !result.empty();
+      } else if (std::isdigit(static_cast<unsigned char>(ch))) {
+        while (pos < body.size() && IsIdentifierChar(body[pos]))
+          result.push_back(body[pos++]);
+      } else {
+        result.push_back(ch);
+        ++pos;
+      }
+    }
+    return result;
+  }
+
+  // Expand macros in comment-free text. A replacement is rescanned together
+  // with the text following it, and a macro is not expanded again inside its
+  // own replacement, which stops recursion. Macros in outer are being
+  // expanded by the caller and are not expanded at all. If open_call is given
+  // and text ends inside a function-like macro call or right after its name,
+  // it is set and expansion stops, as the call continues on the next line.
+  std::string Expand(std::string text, const std::set<std::string> &outer,
+                     bool *open_call = nullptr) {
+    // Macros being expanded and the end of their replacement in text
+    std::vector<std::pair<std::string, std::size_t>> hidden;
+    auto is_hidden = [&hidden](const std::string &name, std::size_t pos) {
+      for (auto &entry : hidden) {
+        if (entry.first == name && entry.second > pos)
+          return true;
+      }
+      return false;
+    };
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+      char ch = text[pos];
+      if (ch == '"' || ch == '\'') {
+        ReadLiteral(text, pos);
+        continue;
+      }
+      // Numbers such as 0x1F are not identifiers
+      if (std::isdigit(static_cast<unsigned char>(ch))) {
+        while (pos < text.size() && IsIdentifierChar(text[pos]))
+          ++pos;
+        continue;
+      }
+      if (!IsIdentifierStart(ch)) {
+        ++pos;
+        continue;
+      }
+      std::size_t begin = pos;
+      std::string name = ReadIdentifier(text, pos);
+      auto iter = macros_.find(name);
+      if (iter == macros_.end() || outer.count(name) || is_hidden(name, begin))
+        continue;
+      const Macro &macro = iter->second;
+      std::string replacement;
+      std::size_t end = pos;
+      if (!macro.function_like) {
+        replacement = macro.body;
+      } else {
+        SkipSpace(text, end);
+        std::vector<std::string> args;
+        if (open_call) {
+          std::size_t look = end;
+          if (look == text.size() ||
+              (text[look] == '(' && !ReadArguments(text, look, args))) {
+            *open_call = true;
+            return text;
+          }
+          args.clear();
+        }
+        // A function-like macro name without arguments is not a call
+        if (end == text.size() || text[end] != '(')
+          continue;
+        if (!ReadArguments(text, end, args)) {
+          PrintError(MACRO_ARG_NO_END, name);
+          continue;
+        }
+        if (macro.params.empty() && args.size() == 1 && Trim(args[0]).empty())
+          args.clear();
+        if (args.size() != macro.params.size()) {
+          PrintError(MACRO_ARG_ERR, name);
+          continue;
+        }
+        // Arguments are fully expanded before substitution
+        std::set<std::string> disabled = outer;
+        for (auto &entry : hidden) {
+          if (entry.second > begin)
+            disabled.insert(entry.first);
+        }
+        for (auto &arg : args)
+          arg = Expand(Trim(arg), disabled);
+        replacement = Substitute(macro, args);
+      }
+      // Keep the replacement from joining with its neighbours, as "-" and
+      // "-1" would become "--1"
+      char left = begin > 0 ? text[begin - 1] : ' ';
+      char right = end < text.size() ? text[end] : ' ';
+      if (replacement.empty()) {
+        if (Joins(left, right))
+          replacement = " ";
+      } else {
+        if (Joins(left, replacement.front()))
+          replacement.insert(0, 1, ' ');
+        if (Joins(replacement.back(), right))
+          replacement.push_back(' ');
+      }
+      text.replace(begin, end - begin, replacement);
+      // A replacement ending inside the replaced call now ends with the new
+      // replacement
+      for (auto &entry : hidden) {
+        if (entry.second >= end)
+          entry.second = entry.second - end + begin + replacement.size();
+        else if (entry.second > begin)
+          entry.second = begin + replacement.size();
+      }
+      hidden.emplace_back(name, begin + replacement.size());
+      pos = begin;
+    }
+    return text;
+  }
+
+  // Conditional expression
+  // Operands that do not decide the result of &&, || and ?: are parsed with
+  // eval false, so that errors such as division by zero in them are ignored.
+  // <cond>-><binary> | <binary> ? <cond> : <cond>
+  long ParseCondition(const std::string &text, std::size_t &pos, bool eval,
+                      bool &ok) {
+    long value = ParseBinary(text, pos, 1, eval, ok);
+    SkipSpace(text, pos);
+    if (ok && pos < text.size() && text[pos] == '?') {
+      ++pos;
+      long true_value = ParseCondition(text, pos, eval && value, ok);
+      SkipSpace(text, pos);
+      if (pos == text.size() || text[pos] != ':') {
+        ok = false;
+        return 0;
+      }
+      ++pos;
+      long false_value = ParseCondition(text, pos, eval && !value, ok);
+      value = value ? true_value : false_value;
+    }
+    return value;
+  }
+
+  // Binary operators from lowest to highest precedence, longest first
+  static int MatchOperator(const std::string &text, std::size_t pos,
+                           std::string &op) {
+    static const std::vector<std::pair<std::string, int>> operators = {
+        {"||", 1}, {"&&", 2}, {"==", 6}, {"!=", 6}, {"<=", 7}, {">=", 7},
+        {"<<", 8}, {">>", 8}, {"|", 3},  {"^", 4},  {"&", 5},  {"<", 7},
+        {">", 7},  {"+", 9},  {"-", 9},  {"*", 10}, {"/", 10}, {"%", 10}};
+    for (auto &entry : operators) {
+      if (text.compare(pos, entry.first.size(), entry.first) == 0) {
+        op = entry.first;
+        return entry.second;
+      }
+    }
+    return 0;
+  }
+
+  long ParseBinary(const std::string &text, std::size_t &pos, int min_prec,
+                   bool eval, bool &ok) {
+    long lhs = ParseUnary(text, pos, eval, ok);
+    while (ok) {
+      SkipSpace(text, pos);
+      std::string op;
+      int prec = MatchOperator(text, pos, op);
+      if (prec < min_prec || prec == 0)
+        break;
+      pos += op.size();
+      // Short circuit
+      bool eval_rhs = eval;
+      if (op == "&&")
+        eval_rhs = eval && lhs;
+      else if (op == "||")
+        eval_rhs = eval && !lhs;
+      long rhs = ParseBinary(text, pos, prec + 1, eval_rhs, ok);
+      if (ok && eval && !Apply(op, lhs, rhs, lhs))
+        ok = false;
+    }
+    return eval ? lhs : 0;
+  }
+
+  // Compute lhs op rhs into value, return false if the result is undefined.
+  // +, - and * wrap around as unsigned long instead of overflowing.
+  static bool Apply(const std::string &op, long lhs, long rhs, long &value) {
+    using ulong = unsigned long;
+    constexpr int bits = sizeof(long) * 8;
+    // Shift count out of range, division by zero and LONG_MIN / -1
+    if ((op == "<<" || op == ">>") && (rhs < 0 || rhs >= bits))
+      return false;
+    if ((op == "/" || op == "%") &&
+        (rhs == 0 || (lhs == std::numeric_limits<long>::min() && rhs == -1)))
+      return false;
+    if (op == "||")
+      value = lhs || rhs;
+    else if (op == "&&")
+      value = lhs && rhs;
+    else if (op == "|")
+      value = lhs | rhs;
+    else if (op == "^")
+      value = lhs ^ rhs;
+    else if (op == "&")
+      value = lhs & rhs;
+    else if (op == "==")
+      value = lhs == rhs;
+    else if (op == "!=")
+      value = lhs != rhs;
+    else if (op == "<")
+      value = lhs < rhs;
+    else if (op == "<=")
+      value = lhs <= rhs;
+    else if (op == ">")
+      value = lhs > rhs;
+    else if (op == ">=")
+      value = lhs >= rhs;
+    else if (op == "<<")
+      value = static_cast<long>(static_cast<ulong>(lhs) << rhs);
+    else if (op == ">>")
+      value = lhs >> rhs;
+    else if (op == "+")
+      value = static_cast<long>(static_cast<ulong>(lhs) +
+                                static_cast<ulong>(rhs));
+    else if (op == "-")
+      value = static_cast<long>(static_cast<ulong>(lhs) -
+                                static_cast<ulong>(rhs));
+    else if (op == "*")
+      value = static_cast<long>(static_cast<ulong>(lhs) *
+                                static_cast<ulong>(rhs));
+    else if (op == "/")
+      value = lhs / rhs;
+    else
+      value = lhs % rhs;
+    return true;
+  }
+
+  // <unary>->! <unary> | - <unary> | + <unary> | ~ <unary> | <primary>
+  long ParseUnary(const std::string &text, std::size_t &pos, bool eval,
+                  bool &ok) {
+    SkipSpace(text, pos);
+    if (pos == text.size()) {
+      ok = false;
+      return 0;
+    }
+    char ch = text[pos];
+    if (ch == '!' || ch == '-' || ch == '+' || ch == '~') {
+      ++pos;
+      long value = ParseUnary(text, pos, eval, ok);
+      if (ch == '!')
+        return !value;
+      else if (ch == '-')
+        return static_cast<long>(0UL - static_cast<unsigned long>(value));
+      else if (ch == '~')
+        return ~value;
+      return value;
+    }
+    return ParsePrimary(text, pos, eval, ok);
+  }
+
+  // <primary>->( <cond> ) | num | ch | id
+  long ParsePrimary(const std::string &text, std::size_t &pos, bool eval,
+                    bool &ok) {
+    char ch = text[pos];
+    if (ch == '(') {
+      ++pos;
+      long value = ParseCondition(text, pos, eval, ok);
+      SkipSpace(text, pos);
+      if (pos == text.size() || text[pos] != ')') {
+        ok = false;
+        return 0;
+      }
+      ++pos;
+      return value;
+    }
+    if (std::isdigit(static_cast<unsigned char>(ch))) {
+      std::size_t begin = pos;
+      while (pos < text.size() && IsIdentifierChar(text[pos]))
+        ++pos;
+      std::string num = text.substr(begin, pos - begin);
+      // All #if arithmetic is signed, so an unsigned constant would give
+      // wrong results in comparisons, /, % and >>; reject it instead
+      while (!num.empty() && (std::tolower(num.back()) == 'u' ||
+                              std::tolower(num.back()) == 'l')) {
+        if (std::tolower(num.back()) == 'u')
+          ok = false;
+        num.pop_back();
+      }
+      // Binary numbers are supported by the Lexer too
+      bool binary = num.size() > 2 && num[0] == '0' && num[1] == 'b';
+      char *end = nullptr;
+      long value = binary ? std::strtol(num.c_str() + 2, &end, 2)
+                          : std::strtol(num.c_str(), &end, 0);
+      if (num.empty() || *end != '\0')
+        ok = false;
+      return value;
+    }
+    if (ch == '\'') {
+      std::string literal = ReadLiteral(text, pos);
+      if (literal.size() < 3 || literal.back() != '\'') {
+        ok = false;
+        return 0;
+      }
+      if (literal[1] != '\\')
+        return literal[1];
+      switch (literal[2]) {
+      case 'n':
+        return '\n';
+      case 't':
+        return '\t';
+      case '0':
+        return '\0';
+      default:
+        return literal[2];
+      }
+    }
+    // Identifiers left after macro expansion evaluate to 0
+    if (IsIdentifierStart(ch)) {
+      ReadIdentifier(text, pos);
+      return 0;
+    }
+    ok = false;
+    return 0;
+  }
+
+  bool EvaluateCondition(const std::string &text) {
+    // Replace defined X and defined(X) before macro expansion
+    std::string replaced;
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+      if (!IsIdentifierStart(text[pos])) {
+        if (text[pos] == '\'') {
+          replaced += ReadLiteral(text, pos);
+        } else {
+          replaced.push_back(text[pos++]);
+        }
+        continue;
+      }
+      std::string name = ReadIdentifier(text, pos);
+      if (name != "defined") {
+        replaced += name;
+        continue;
+      }
+      SkipSpace(text, pos);
+      bool paren = pos < text.size() && text[pos] == '(';
+      if (paren) {
+        ++pos;
+        SkipSpace(text, pos);
+      }
+      std::string macro = ReadIdentifier(text, pos);
+      SkipSpace(text, pos);
+      if (macro.empty() ||
+          (paren && (pos == text.size() || text[pos] != ')'))) {
+        PrintError(IF_EXPR_INVALID, Trim(text));
+        return false;
+      }
+      if (paren)
+        ++pos;
+      replaced += macros_.count(macro) ? " 1 " : " 0 ";
+    }
+    std::string expanded = Expand(replaced, std::set<std::string>());
+    bool ok = true;
+    pos = 0;
+    long value = ParseCondition(expanded, pos, true, ok);
+    SkipSpace(expanded, pos);
+    if (!ok || pos != expanded.size()) {
+      PrintError(IF_EXPR_INVALID, Trim(text));
+      return false;
+    }
+    return value != 0;
+  }
+
+  // Directives
+  // Conditional directives are handled in skipped groups too
+  bool HandleConditional(const std::string &name, const std::string &text,
+                         std::size_t pos) {
+    FileState &file = files_.back();
+    if (name == "if" || name == "ifdef" || name == "ifndef") {
+      bool parent = IsActive();
+      bool value = false;
+      bool guard = false;
+      if (parent && name == "if") {
+        value = EvaluateCondition(text.substr(pos));
+      } else if (parent) {
+        SkipSpace(text, pos);
+        std::string macro = ReadIdentifier(text, pos);
+        if (macro.empty())
+          PrintError(DIRECTIVE_INVALID, "#" + name);
+        value = (macros_.count(macro) != 0) == (name == "ifdef");
+        guard = file.guard_state == GUARD_START && name == "ifndef" &&
+                !macro.empty() && Trim(text.substr(pos)).empty();
+        if (guard) {
+          file.guard_state = GUARD_IN;
+          file.guard = macro;
+        }
+      }
+      if (!guard)
+        OnDirective(file);
+      conditions_.push_back({parent, value, parent && value, false});
+      return true;
+    }
+    if (name == "elif" || name == "else") {
+      if (conditions_.size() == file.cond_base) {
+        PrintError(ELSE_NO_IF, "#" + name);
+        return true;
+      }
+      Condition &cond = conditions_.back();
+      if (cond.has_else)
+        PrintError(ELSE_AFTER_ELSE, "#" + name);
+      if (name == "else") {
+        cond.active = cond.parent_active && !cond.taken;
+        cond.has_else = true;
+      } else {
+        cond.active = cond.parent_active && !cond.taken &&
+                      EvaluateCondition(text.substr(pos));
+      }
+      cond.taken = cond.taken || cond.active;
+      // The guard must wrap the whole file without alternatives
+      if (conditions_.size() == file.cond_base + 1)
+        file.guard_state = GUARD_NONE;
+      return true;
+    }
+    if (name == "endif") {
+      if (conditions_.size() == file.cond_base) {
+        PrintError(ENDIF_NO_IF);
+        return true;
+      }
+      conditions_.pop_back();
+      if (file.guard_state == GUARD_IN &&
+          conditions_.size() == file.cond_base)
+        file.guard_state = GUARD_AFTER;
+      return true;
+    }
+    return false;
+  }
+
+  // Anything but the guard itself outside the guard disables the detection
+  static void OnDirective(FileState &file) {
+    if (file.guard_state != GUARD_IN)
+      file.guard_state = GUARD_NONE;
+  }
+
+  void HandleDefine(const std::string &text, std::size_t pos) {
+    SkipSpace(text, pos);
+    std::string name = ReadIdentifier(text, pos);
+    if (name.empty() || name == "defined") {
+      PrintError(DIRECTIVE_INVALID, "#define");
+      return;
+    }
+    Macro macro;
+    // Only a '(' right after the name makes a function-like macro
+    if (pos < text.size() && text[pos] == '(') {
+      macro.function_like = true;
+      ++pos;
+      SkipSpace(text, pos);
+      if (pos < text.size() && text[pos] == ')') {
+        ++pos;
+      } else {
+        while (true) {
+          SkipSpace(text, pos);
+          std::string param = ReadIdentifier(text, pos);
+          SkipSpace(text, pos);
+          if (param.empty() || pos == text.size() ||
+              (text[pos] != ',' && text[pos] != ')')) {
+            PrintError(DIRECTIVE_INVALID, "#define " + name);
+            return;
+          }
+          macro.params.push_back(param);
+          if (text[pos++] == ')')
+            break;
+        }
+      }
+    }
+    macro.body = Trim(text.substr(pos));
+    // Stringizing and token pasting are not supported, and a '#' left in the
+    // output would be rejected by the Lexer
+    std::size_t look = 0;
+    while (look < macro.body.size()) {
+      char ch = macro.body[look];
+      if (ch == '"' || ch == '\'') {
+        ReadLiteral(macro.body, look);
+        continue;
+      }
+      if (ch == '#' && (macro.function_like ||
+                        macro.body.compare(look, 2, "##") == 0)) {
+        PrintError(DIRECTIVE_INVALID, "#define " + name);
+        return;
+      }
+      ++look;
+    }
+    macros_[name] = std::move(macro);
+  }
+
+  void HandleInclude(const std::string &text, std::size_t pos,
+                     std::string &out) {
+    SkipSpace(text, pos);
+    char close = 0;
+    if (pos < text.size() && text[pos] == '"')
+      close = '"';
+    else if (pos < text.size() && text[pos] == '<')
+      close = '>';
+    std::size_t end =
+        close ? text.find(close, pos + 1) : static_cast<std::size_t>(-1);
+    if (!close || end == std::string::npos ||
+        !Trim(text.substr(end + 1)).empty()) {
+      PrintError(DIRECTIVE_INVALID, "#include");
+      return;
+    }
+    std::string name = text.substr(pos + 1, end - pos - 1);
+    if (files_.size() >= static_cast<std::size_t>(max_include_depth_)) {
+      PrintError(INCLUDE_TOO_DEEP, name);
+      return;
+    }
+    std::string spelled;
+    std::string path = ResolveInclude(name, close == '"', spelled);
+    if (path.empty()) {
+      PrintError(INCLUDE_NOT_FOUND, name);
+      return;
+    }
+    ProcessFile(path, spelled, out);
+  }
+
+  void HandleDirective(const std::string &text, std::string &out) {
+    std::size_t pos = 0;
+    SkipSpace(text, pos);
+    std::string name = ReadIdentifier(text, pos);
+    if (HandleConditional(name, text, pos) || !IsActive())
+      return;
+    OnDirective(files_.back());
+    if (name == "define") {
+      HandleDefine(text, pos);
+    } else if (name == "undef") {
+      SkipSpace(text, pos);
+      std::string macro = ReadIdentifier(text, pos);
+      if (macro.empty())
+        PrintError(DIRECTIVE_INVALID, "#undef");
+      macros_.erase(macro);
+    } else if (name == "include") {
+      HandleInclude(text, pos, out);
+    } else if (name == "pragma") {
+      // Other pragmas are ignored
+      if (Trim(text.substr(pos)) == "once")
+        pragma_once_.insert(files_.back().path);
+    } else if (name == "error") {
+      PrintError(DIRECTIVE_ERROR, Trim(text.substr(pos)));
+    } else if (!name.empty() || !Trim(text.substr(pos)).empty()) {
+      // A '#' alone is the null directive
+      PrintError(DIRECTIVE_UNKNOWN, "#" + name);
+    }
+  }
+
+  // Files
+  std::shared_ptr<const std::string> ReadFile(const std::string &path,
+                                              IncludeStat &stat) {
+    auto iter = file_cache_.find(path);
+    if (iter != file_cache_.end())
+      return iter->second;
+    std::FILE *fp = std::fopen(path.c_str(), "r");
+    if (!fp)
+      return nullptr;
+    auto content = std::make_shared<std::string>();
+    char buf[4096];
+    std::size_t len;
+    while ((len = std::fread(buf, 1, sizeof(buf), fp)) > 0)
+      content->append(buf, len);
+    std::fclose(fp);
+    ++stat.reads;
+    file_cache_[path] = content;
+    return content;
+  }
+
+  // Absolute path without symbolic links, . or .., "" if the file does not
+  // exist. The same file reached through different spellings gets one key.
+  static std::string Canonicalize(const std::string &path) {
+    char *real = ::realpath(path.c_str(), nullptr);
+    if (!real)
+      return "";
+    std::string result(real);
+    std::free(real);
+    return result;
+  }
+
+  // "name" is searched beside the including file first, then in the include
+  // directories; <name> only in the include directories. Return the canonical
+  // path and set spelled to the path as found.
+  std::string ResolveInclude(const std::string &name, bool quoted,
+                             std::string &spelled) {
+    std::vector<std::string> candidates;
+    if (!name.empty() && name[0] == '/') {
+      candidates.push_back(name);
+    } else {
+      if (quoted) {
+        const std::string &current = files_.back().name;
+        std::size_t slash = current.rfind('/');
+        candidates.push_back(
+            (slash == std::string::npos ? "" : current.substr(0, slash + 1)) +
+            name);
+      }
+      for (auto &dir : include_dirs_) {
+        bool slash = dir.empty() || dir.back() == '/';
+        candidates.push_back(slash ? dir + name : dir + "/" + name);
+      }
+    }
+    for (auto &candidate : candidates) {
+      std::string path = Canonicalize(candidate);
+      if (!path.empty()) {
+        spelled = candidate;
+        return path;
+      }
+    }
+    return "";
+  }
+
+  void ProcessFile(const std::string &path, const std::string &name,
+                   std::string &out) {
+    IncludeStat &stat = stats_[path];
+    if (stat.includes++ == 0)
+      stat.name = name;
+    // Skip a guarded header without looking at it again
+    auto guard = include_guards_.find(path);
+    if (pragma_once_.count(path) ||
+        (guard != include_guards_.end() && !guard->second.empty() &&
+         macros_.count(guard->second))) {
+      ++stat.skips;
+      return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    auto content = ReadFile(path, stat);
+    if (!content) {
+      if (files_.empty()) {
+        PrintCommonError(
+            FATAL,
+            "Fail to open the file %s! Please check filename and path.\n",
+            name.c_str());
+        Error::IncrErrorNum();
+      } else {
+        PrintError(INCLUDE_NOT_FOUND, name);
+      }
+      return;
+    }
+    files_.push_back({path, name, 0, conditions_.size(), GUARD_START, ""});
+    bool in_comment = false;
+    std::size_t pos = 0;
+    std::string line;
+    while (pos < content->size()) {
+      int count = ReadLine(*content, pos, line);
+      files_.back().line += 1;
+      MarkLine();
+      std::string code = StripComments(line, in_comment);
+      std::size_t first = code.find_first_not_of(" \t");
+      if (first != std::string::npos && code[first] == '#') {
+        HandleDirective(code.substr(first + 1), out);
+      } else if (first != std::string::npos) {
+        OnDirective(files_.back());
+        if (IsActive()) {
+          // Arguments of a macro call may continue on the following lines,
+          // errors are reported once the whole call is read
+          std::string expanded;
+          bool open_call;
+          quiet_ = true;
+          quiet_errors_ = 0;
+          while (true) {
+            open_call = false;
+            expanded = Expand(code, std::set<std::string>(), &open_call);
+            if (!open_call || pos == content->size())
+              break;
+            std::size_t next = pos;
+            bool next_in_comment = in_comment;
+            int next_count = ReadLine(*content, next, line);
+            std::string next_code = StripComments(line, next_in_comment);
+            std::size_t next_first = next_code.find_first_not_of(" \t");
+            if (next_first != std::string::npos && next_code[next_first] == '#')
+              break;
+            pos = next;
+            in_comment = next_in_comment;
+            count += next_count;
+            code += " " + next_code;
+          }
+          quiet_ = false;
+          if (open_call || quiet_errors_ > 0)
+            expanded = Expand(code, std::set<std::string>());
+          out += expanded;
+        }
+      }
+      out.append(count, '\n');
+      out_line_ += count;
+      files_.back().line += count - 1;
+      stat.lines += count;
+    }
+    stat.bytes += content->size();
+    if (in_comment)
+      PrintError(COMMENT_NOT_END);
+    FileState &file = files_.back();
+    if (conditions_.size() > file.cond_base) {
+      PrintError(IF_NO_ENDIF);
+      conditions_.resize(file.cond_base);
+    }
+    include_guards_[path] = file.guard_state == GUARD_AFTER ? file.guard : "";
+    files_.pop_back();
+    stat.micros += std::chrono::duration<double, std::micro>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  }
+
+public:
+  Preprocessor() = default;
+  Preprocessor(const Preprocessor &) = delete;
+  Preprocessor &operator=(const Preprocessor &) = delete;
+  ~Preprocessor() = default;
+
+  void AddIncludeDir(const std::string &dir) { include_dirs_.push_back(dir); }
+
+  // Predefine an object-like macro, as -D on the command line
+  void Define(const std::string &name, const std::string &body = "1") {
+    Macro macro;
+    macro.body = body;
+    predefined_[name] = macro;
+  }
+
+  // Preprocess a translation unit. Macros are reset for each unit while the
+  // file cache and include guards are kept. Pass GetLineMarks() to the
+  // Scanner along with the result so that positions refer to source files.
+  std::string Preprocess(const std::string &file_name) {
+    macros_ = predefined_;
+    conditions_.clear();
+    files_.clear();
+    pragma_once_.clear();
+    out_line_ = 1;
+    line_marks_.clear();
+    std::string out;
+    std::string path = Canonicalize(file_name);
+    ProcessFile(path.empty() ? file_name : path, file_name, out);
+    return out;
+  }
+
+  const std::vector<LineMark> &GetLineMarks() const { return line_marks_; }
+
+  // Print per-header cost, time includes nested headers. Each file is listed
+  // once under the path it was first reached through.
+  void PrintStatistics() const {
+    std::printf("%-32s %8s %8s %8s %8s %10s %10s\n", "file", "include", "skip",
+                "read", "line", "byte", "time(us)");
+    for (auto &entry : stats_) {
+      const IncludeStat &stat = entry.second;
+      std::printf("%-32s %8d %8d %8d %8d %10zu %10.1f\n", stat.name.c_str(),
+                  stat.includes, stat.skips, stat.reads, stat.lines, stat.bytes,
+                  stat.micros);
+    }
+  }
+
+private:
+  // Debug helper
+  static void TestImpl(const char *file_name) {
+    Preprocessor preprocessor;
+    preprocessor.AddIncludeDir("file/include");
+    std::string text = preprocessor.Preprocess(file_name);
+    auto scanner = std::make_shared<Scanner>(file_name, text,
+                                             preprocessor.GetLineMarks());
+    Lexer lexer(scanner);
+    std::shared_ptr<Token> token;
+    do {
+      token = lexer.Tokenize();
+      std::printf("%24s<line %3d>\t", scanner->GetFile(), scanner->GetLine());
+      std::printf("%10s\t", Token::GetTagName(token->GetTag()).c_str());
+      std::printf("%20s\n", token->ToString().c_str());
+      std::fflush(stdout);
+    } while (token->GetTag() != END);
+    std::printf("Finish the preprocess for %s\n", file_name);
+    preprocessor.PrintStatistics();
+  }
+
+public:
+  static void MainTest(int argc = 0, char *argv[] = nullptr) {
+    TestImpl("file/preprocess.c");
+    printf("\n");
+    TestImpl("file/preprocess_error.c");
+  }
+};
+} // namespace akan
@@ -1,9 +1,20 @@
 #pragma once
 #include "error.h"
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace akan {
+// Maps preprocessed text back to the source, following lines continue from
+// the mark up to the next one
+struct LineMark {
+  int line;         // line in the preprocessed text
+  std::string file; // source file
+  int source_line;  // line in the source file
+};
+
 class Scanner {
 
   static void CloseFile(std::FILE *fp) {
@@ -15,6 +26,12 @@ class Scanner {
   const char *file_name_ = nullptr;
   std::unique_ptr<FILE, decltype(CloseFile) *> file_;
 
+  // In-memory source, e.g. output of the preprocessor
+  bool from_memory_ = false;
+  std::string content_;
+  std::size_t content_pos_ = 0;
+  std::vector<LineMark> line_marks_; // sorted by line
+
   // Characters read
   static constexpr int buf_len_ = 80; // Length of scan buffer
   char line_[buf_len_];
@@ -26,6 +43,25 @@ class Scanner {
   int line_num_ = 1;  // Row Number
   int col_num_ = 0;   // Column Number
 
+  // Fill the scan buffer from the file or the in-memory source
+  int Reload() {
+    if (file_)
+      return std::fread(line_, 1, buf_len_, file_.get());
+    std::size_t len =
+        std::min<std::size_t>(buf_len_, content_.size() - content_pos_);
+    content_.copy(line_, len, content_pos_);
+    content_pos_ += len;
+    return len;
+  }
+
+  // Last line mark at or before the current line
+  const LineMark *FindLineMark() const {
+    auto iter = std::upper_bound(
+        line_marks_.begin(), line_marks_.end(), line_num_,
+        [](int line, const LineMark &mark) { return line < mark.line; });
+    return iter == line_marks_.begin() ? nullptr : &*(iter - 1);
+  }
+
   // Debug helper
   static std::string ShowChar(char ch) {
     char s[16];
@@ -59,17 +95,24 @@ public:
     }
   }
 
+  // Scan an in-memory source, name is only used for diagnostics. Positions
+  // are reported in source files according to line_marks if given.
+  Scanner(const char *name, std::string content,
+          std::vector<LineMark> line_marks = {})
+      : file_name_(name), file_(nullptr, &CloseFile), from_memory_(true),
+        content_(std::move(content)), line_marks_(std::move(line_marks)) {}
+
   Scanner(const Scanner &) = delete;
   Scanner &operator=(const Scanner &) = delete;
   ~Scanner() = default;
 
   // Scan characters from  buffer
   int Scan() {
-    if (!file_)
+    if (!file_ && !from_memory_)
       return -1;
     if (read_pos_ == line_len_ - 1) {
-      line_len_ = fread(line_, 1, buf_len_, file_.get()); // reload buffer data
-      if (line_len_ == 0) {                               // no data
+      line_len_ = Reload(); // reload buffer data
+      if (line_len_ == 0) { // no data
         // indicate end of file
         line_len_ = 1;
         line_[0] = -1;
@@ -91,8 +134,14 @@ public:
   }
 
   // Getter
-  const char *GetFile() const { return file_name_; }
-  int GetLine() const { return line_num_; }
+  const char *GetFile() const {
+    const LineMark *mark = FindLineMark();
+    return mark ? mark->file.c_str() : file_name_;
+  }
+  int GetLine() const {
+    const LineMark *mark = FindLineMark();
+    return mark ? mark->source_line + line_num_ - mark->line : line_num_;
+  }
   int GetCol() const { return col_num_; }
 
 private:
@@ -0,0 +1,8 @@
+#include "preprocessor.h"
+using namespace akan;
+
+int main() {
+
+  Preprocessor::MainTest();
+  return 0;
+}
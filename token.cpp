@@ -7,7 +7,7 @@ std::array<const char *, 48> Token::tag_name_ = {
     "--",     ">",           ">=",         "<",      "<=",       "==",
     "!=",     "&&",          "||",         "(",      ")",        "[",
     "]",      "{",           "}",          ",",      ":",        ";",
-    "=",      "if",          "else",       "switch", "else",     "default",
+    "=",      "if",          "else",       "switch", "case",     "default",
     "while",  "do",          "for",        "break",  "continue", "return"};
 
 std::unordered_map<std::string, Tag> Keyword::keywords_ = {